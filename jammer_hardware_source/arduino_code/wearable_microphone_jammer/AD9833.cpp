@@ -54,6 +54,9 @@ AD9833 :: AD9833 ( uint8_t FNCpin, uint32_t referenceFrequency ) {
 	frequency0 = frequency1 = 1000;		// 1 KHz sine wave to start
 	phase0 = phase1 = 0.0;				// 0 phase
 	activeFreq = REG0; activePhase = REG0;
+#ifdef AD9833_TRACE
+	traceCount = traceDropped = 0;
+#endif
 }
 
 /*
@@ -301,6 +304,31 @@ float AD9833 :: GetResolution ( void ) {
 	return (float)refFrequency / (float)pow2_28;
 }
 
+#ifdef AD9833_TRACE
+/*
+ * Print the logged register writes, one "<usec> <hex word>" line each,
+ * and clear the log. The time is taken when FNCpin goes HIGH, which is
+ * when the AD9833 latches the word. If the log filled up, a
+ * "% dropped <n>" line tells that writes are missing and the emulation
+ * in simulation/hop_glitch.m will not match the real output.
+ * The log ends with a "% dump" line, so that simulation/hop_glitch.m
+ * can leave out the time spent printing when timing the hops.
+ */
+void AD9833 :: DumpTrace ( Print &out ) {
+	for ( uint16_t i = 0; i < traceCount; i++ ) {
+		out.print(traceTime[i]);
+		out.print(' ');
+		out.println(traceWord[i],HEX);
+	}
+	if ( traceDropped ) {
+		out.print(F("% dropped "));
+		out.println(traceDropped);
+	}
+	out.println(F("% dump"));
+	traceCount = traceDropped = 0;
+}
+#endif
+
 // --------------------- PRIVATE FUNCTIONS --------------------------
 
 /*
@@ -360,4 +388,12 @@ void AD9833 :: WriteRegister ( int16_t dat ) {
 	SPI.transfer(lowByte(dat));
 
 	WRITE_FNCPIN(HIGH);		// Write done
+
+#ifdef AD9833_TRACE
+	if ( traceCount < AD9833_TRACE ) {
+		traceTime[traceCount] = micros();
+		traceWord[traceCount++] = dat;
+	}
+	else if ( traceDropped < 0xFFFF ) traceDropped++;
+#endif
 }
@@ -38,6 +38,11 @@
 	#define WRITE_FNCPIN(Val) digitalWrite(FNCpin,(Val))
 #endif
 
+//#define AD9833_TRACE 64		// Define to log up to N register writes
+
+// The log is read back with DumpTrace and analyzed for glitches by
+// simulation/hop_glitch.m. Logging adds a micros() call to every write.
+
 #define pow2_28				268435456L	// 2^28 used in frequency word calculation
 #define BITS_PER_DEG		11.3777777777778	// 4096 / 360
 
@@ -121,6 +126,12 @@ public:
 	// Return frequency resolution 
 	float GetResolution ( void );
 
+#ifdef AD9833_TRACE
+	// Print logged register writes as "<usec> <hex word>" lines, then
+	// clear the log
+	void DumpTrace ( Print &out );
+#endif
+
 private:
 
 	void 			WriteRegister ( int16_t dat );
@@ -133,6 +144,11 @@ private:
 	uint32_t		refFrequency;
 	float			frequency0, frequency1, phase0, phase1;
 	Registers		activeFreq, activePhase;
+#ifdef AD9833_TRACE
+	uint32_t		traceTime[AD9833_TRACE];
+	uint16_t		traceWord[AD9833_TRACE];
+	uint16_t		traceCount, traceDropped;
+#endif
 };
 
 #endif
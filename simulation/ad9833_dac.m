@@ -0,0 +1,29 @@
+function y = ad9833_dac(ctrl, q, on, ideal)
+    % VOUT of the AD9833 for the control words ctrl and the phase q
+    % (28-bit units, mod 2^29), both per sample. The output is midscale
+    % where on is false. With ideal set, the sine and triangle are not
+    % quantized, so that quantization noise does not mask small glitches.
+    ctrl = ctrl .* ones(size(q));
+    on = on & true(size(q));
+    p = mod(q, 2^28);
+    if ideal
+        y = sin(2 * pi * p / 2^28);
+        tri = 1 - 4 * abs(p / 2^28 - 0.5);
+    else
+        % 12-bit phase into the sine ROM, 10-bit DAC
+        y = round(511 * sin(2 * pi * floor(p / 2^16) / 4096)) / 511;
+        tri = 1 - 4 * abs(floor(p / 2^18) / 1024 - 0.5);
+    end
+    m = bit(ctrl, 1);
+    y(m) = tri(m);
+    y(bit(ctrl, 6)) = 0;
+    m = bit(ctrl, 5) & bit(ctrl, 3);
+    y(m) = 2 * (p(m) >= 2^27) - 1;
+    m = bit(ctrl, 5) & ~bit(ctrl, 3);
+    y(m) = 2 * (q(m) >= 2^28) - 1;
+    y(~on) = 0;
+end
+
+function b = bit(x, n)
+    b = mod(floor(x / 2^n), 2) == 1;
+end
@@ -0,0 +1,144 @@
+function em = ad9833_emulate(t, w, mclk, fs, b28_atomic)
+    % Emulates the AD9833 output for the register writes w (16-bit words)
+    % latched at times t (us). The output em.y is sampled at fs, full
+    % scale is +-1, from the phase em.q (28-bit units, mod 2^29), the
+    % control word em.ctrl and em.on, which is false in RESET. For every
+    % write k the emulator also records
+    %   em.n(k):em.last(k)  samples until the next write
+    %   em.armed(k)         output was running before the write
+    %   em.hop(k)           the write changed the intended frequency
+    %   em.jump_deg(k)      phase discontinuity caused by the write
+    %   em.half_hz(k)       for the write that completes a half-written
+    %   em.half_us(k)       tuning word: how far the half word strayed
+    %   em.half_from(k)     outside the hop, for how long, and the
+    %                       write that started it
+    % em.q_ref and em.y_ref are the glitch-free hop sequence. Once the
+    % output is running, it advances without interruption at the last
+    % completely written tuning word of the selected register, and only
+    % changes phase when a phase register is written.
+    nw = length(w);
+    em.n = floor(t * 1e-6 * fs) + 1;
+    N = em.n(end) + round(1e-3 * fs);
+    em.last = [em.n(2:end) - 1; N];
+    em.q = zeros(N, 1);
+    em.q_ref = zeros(N, 1);
+    em.ctrl = zeros(N, 1);
+    em.on = false(N, 1);
+    em.armed = false(nw, 1);
+    em.hop = false(nw, 1);
+    em.jump_deg = zeros(nw, 1);
+    em.half_hz = NaN(nw, 1);
+    em.half_us = NaN(nw, 1);
+    em.half_from = zeros(nw, 1);
+
+    % power up in RESET until the first control write
+    ctrl = 256;
+    freq = [0 0];       % tuning words as seen by the phase accumulator
+    done = [0 0];       % last completely written tuning words
+    lsb = [0 0];
+    pending = [0 0];
+    lsb_at = [0 0];
+    lsb_active = [0 0];
+    phase = [0 0];
+    acc = 0;
+    acc_ref = 0;
+    live = false;
+    q_prev = 0;
+
+    for k = 1:nw
+        fsel = 1 + bit(ctrl, 11);
+        em.armed(k) = ~bit(ctrl, 8) && done(fsel) > 0;
+        old = done(fsel);
+
+        wk = w(k);
+        d = mod(wk, 2^14);
+        switch floor(wk / 2^14)
+            case 0
+                ctrl = wk;
+                pending = [0 0];
+            case {1, 2}
+                r = floor(wk / 2^14);
+                if bit(ctrl, 13)
+                    % B28: LSB and MSB in two consecutive writes
+                    if ~pending(r)
+                        lsb(r) = d;
+                        pending(r) = 1;
+                        lsb_at(r) = k;
+                        lsb_active(r) = em.armed(k) && r == fsel;
+                        if ~b28_atomic
+                            freq(r) = floor(freq(r) / 2^14) * 2^14 + d;
+                        end
+                    else
+                        prev = done(r);
+                        freq(r) = d * 2^14 + lsb(r);
+                        done(r) = freq(r);
+                        pending(r) = 0;
+                        half = floor(prev / 2^14) * 2^14 + lsb(r);
+                        if ~b28_atomic && lsb_active(r) && ...
+                                half ~= prev && half ~= done(r)
+                            stray = max([0, half - max(prev, done(r)), ...
+                                         min(prev, done(r)) - half]);
+                            em.half_hz(k) = stray * mclk / 2^28;
+                            em.half_us(k) = t(k) - t(lsb_at(r));
+                            em.half_from(k) = lsb_at(r);
+                        end
+                    end
+                elseif bit(ctrl, 12)
+                    freq(r) = d * 2^14 + mod(freq(r), 2^14);
+                    done(r) = freq(r);
+                else
+                    freq(r) = floor(freq(r) / 2^14) * 2^14 + d;
+                    done(r) = freq(r);
+                end
+            case 3
+                phase(1 + bit(wk, 13)) = mod(wk, 2^12);
+        end
+        fsel = 1 + bit(ctrl, 11);
+        psel = 1 + bit(ctrl, 10);
+        em.hop(k) = em.armed(k) && done(fsel) ~= old;
+
+        % output until the next write
+        idx = em.n(k):em.last(k);
+        L = length(idx);
+        if L == 0
+            continue;
+        end
+        if bit(ctrl, 8)
+            step = 0;
+            acc = 0;
+            seg = zeros(L, 1);
+        elseif bit(ctrl, 7)
+            step = 0;
+            seg = acc * ones(L, 1);
+        else
+            step = freq(fsel) * mclk / fs;
+            seg = mod(acc + (1:L)' * step, 2^29);
+            acc = seg(end);
+        end
+        % accumulator is kept mod 2^29 for the MSB/2 square wave
+        q = mod(seg + phase(psel) * 2^16, 2^29);
+        em.q(idx) = q;
+        em.ctrl(idx) = ctrl;
+        em.on(idx) = ~bit(ctrl, 8);
+
+        % the reference follows the output until it first runs
+        live = live || em.armed(k);
+        if live
+            seg = mod(acc_ref + (1:L)' * done(fsel) * mclk / fs, 2^29);
+        end
+        acc_ref = seg(end);
+        em.q_ref(idx) = mod(seg + phase(psel) * 2^16, 2^29);
+
+        if em.armed(k)
+            jump = mod(q(1) - q_prev - step + 2^27, 2^28) - 2^27;
+            em.jump_deg(k) = jump * 360 / 2^28;
+        end
+        q_prev = q(end);
+    end
+    em.y = ad9833_dac(em.ctrl, em.q, em.on, false);
+    em.y_ref = ad9833_dac(em.ctrl, em.q_ref, true, false);
+end
+
+function b = bit(x, n)
+    b = mod(floor(x / 2^n), 2) == 1;
+end
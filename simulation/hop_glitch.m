@@ -0,0 +1,198 @@
+clear;
+
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+% Glitch analysis of AD9833 frequency hops
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+% Every SPI write to the AD9833 is replayed on an emulated chip, and each
+% write is checked for phase discontinuities, half-written tuning words
+% and out-of-band energy. Each log is one firmware build, so changes to
+% the hop path can be compared for both speed and spectral cleanliness.
+%
+% Logs are printed by AD9833::DumpTrace after defining AD9833_TRACE in
+% AD9833.h, one "<usec> <hex word>" line per write.
+
+% logs to compare, one per firmware build. Leave empty to analyze a
+% synthetic log of the shipped loop()
+trace_files = {};
+
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+% Settings
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+% reference clock of the AD9833 module
+mclk = 25e6;
+% sampling rate of the emulated output, should divide mclk
+fs = 1e6;
+% jamming band (Hz), everything outside counts as out-of-band
+band = [24000 26000];
+
+% 1 if a 28-bit tuning word only takes effect on the MSB write (B28 = 1),
+% 0 for the worst case where the LSB write already reaches the output
+b28_atomic = 0;
+
+% thresholds above which a write counts as a glitch
+% phase jump (degree)
+max_phase_jump = 1;
+% out-of-band energy (dB relative to 1ms of full-scale carrier)
+max_oob_db = -60;
+% length of the band-stop filter for the out-of-band energy (s). Longer
+% filters have a narrower transition around the jamming band
+oob_fir = 1e-3;
+
+% synthetic log: time per WriteRegister call and for the rest of loop()
+% between two hops (us). A dump in a real log is shortened to write_us
+write_us = 17.6;
+loop_us = 40;
+n_hops = 200;
+seed = 0;
+
+%%%%%%%%%%%%%%%%%%
+% Load logs
+%%%%%%%%%%%%%%%%%%
+
+builds = {};
+traces = {};
+if isempty(trace_files)
+    % setup() and loop() of wearable_microphone_jammer.ino
+    rng(seed);
+    lsb = @(f) mod(floor(f * 2^28 / mclk), 2^14);
+    msb = @(f) floor(floor(f * 2^28 / mclk) / 2^14);
+    apply = @(ctrl, f) [ctrl; 2^14 + lsb(f); 2^14 + msb(f); ...
+                        hex2dec('E000'); ctrl; ctrl];
+    w = [hex2dec('0100'); apply(hex2dec('2100'), 25000); hex2dec('2000')];
+    t = (0:length(w)-1)' * write_us;
+    for i = 1:n_hops
+        ws = apply(hex2dec('2000'), randi([24000 25999]));
+        t = [t; t(end) + loop_us + (1:length(ws))' * write_us];
+        w = [w; ws];
+    end
+    builds{1} = 'synthetic loop()';
+    traces{1} = [t w zeros(size(t))];
+else
+    for i = 1:length(trace_files)
+        [~, name, ~] = fileparts(trace_files{i});
+        [t, w, gap] = read_trace(trace_files{i});
+        % loop() is blocked while dumping, do not emulate that time
+        d = diff(t);
+        d(gap(2:end)) = write_us;
+        t = [0; cumsum(d)];
+        builds{i} = name;
+        traces{i} = [t w gap];
+    end
+end
+
+%%%%%%%%%%%%%%%%%%
+% Score builds
+%%%%%%%%%%%%%%%%%%
+
+% zero-phase band-stop FIR, Blackman window. The notch is widened by
+% half the transition width on each side to remove the band completely
+D = round(oob_fir * fs / 2);
+m = (-D:D)';
+tw = 5.5 * fs / (2 * D + 1);
+lowpass = @(fc) sin(2 * pi * fc / fs * m) ./ (pi * m + (m == 0)) + ...
+                (m == 0) * 2 * fc / fs;
+win = 0.42 - 0.5 * cos(pi * (m + D) / D) + 0.08 * cos(2 * pi * (m + D) / D);
+h = -(lowpass(band(2) + tw / 2) - lowpass(band(1) - tw / 2)) .* win;
+h(D + 1) = h(D + 1) + 1;
+
+fprintf('%-20s %5s %9s %6s | %5s %9s | %5s %9s %9s | %5s %9s\n', ...
+        'build', 'hops', 'hops/s', 'writes', ...
+        'jumps', 'worst deg', 'half', 'worst Hz', 'worst us', ...
+        'oob', 'worst dB');
+for b = 1:length(builds)
+    t = traces{b}(:, 1);
+    w = traces{b}(:, 2);
+    % number of dumps up to each write, time across a dump is not real
+    dumps = cumsum(traces{b}(:, 3));
+    em = ad9833_emulate(t, w, mclk, fs, b28_atomic);
+
+    a = find(em.armed);
+    if isempty(a)
+        fprintf('%-20s no output, never left RESET with a tuning word\n', ...
+                builds{b});
+        continue;
+    end
+
+    % Out-of-band energy added by each write. The glitch-free hop
+    % sequence is compared with the same sequence carrying only the
+    % deviation of this write: the actual output until the next write,
+    % and the phase offset it left behind after that. Later writes are
+    % identical in both, so their glitches are not counted here, and a
+    % phase offset alone adds no out-of-band energy.
+    N = length(em.q);
+    oob_db = -Inf(size(w));
+    for k = a'
+        n0 = em.n(k);
+        n1 = em.last(k);
+        if n0 < 2 || n1 < n0
+            continue;
+        end
+        % the time before the next write is not real across a dump
+        if k < length(w) && dumps(k + 1) ~= dumps(k)
+            oob_db(k) = NaN;
+            continue;
+        end
+        r = (max(n0 - 2 * D, 1):min(n1 + 2 * D, N))';
+        dq = mod(em.q(r) - em.q_ref(r) + 2^28, 2^29) - 2^28;
+        dq = dq - dq(r == n0 - 1);
+        dq(r < n0) = 0;
+        dq(r > n1) = dq(r == n1);
+        on = em.on(r) | r < n0 | r > n1;
+        y_ref = ad9833_dac(em.ctrl(r), em.q_ref(r), true, true);
+        y_k = ad9833_dac(em.ctrl(r), em.q_ref(r) + dq, on, true);
+        excess = sum(conv(y_k, h, 'valid') .^ 2) - ...
+                 sum(conv(y_ref, h, 'valid') .^ 2);
+        oob_db(k) = 10 * log10(max(excess, 0) / fs / 0.5e-3);
+    end
+
+    % speed from the time between consecutive hops
+    hops = a(em.hop(a));
+    n_hop = length(hops);
+    period = diff(t(hops));
+    period = period(dumps(hops(2:end)) == dumps(hops(1:end-1)));
+    if isempty(period)
+        hop_rate = 0;
+    else
+        hop_rate = 1e6 / median(period);
+    end
+    if n_hop > 0
+        writes_per_hop = length(a) / n_hop;
+    else
+        writes_per_hop = 0;
+    end
+
+    [jump, kj] = max(abs(em.jump_deg(a)));
+    n_jump = sum(abs(em.jump_deg(a)) > max_phase_jump);
+
+    % half words that span a dump have no real duration
+    half = a(~isnan(em.half_hz(a)));
+    cut = dumps(half) ~= dumps(em.half_from(half));
+    em.half_us(half(cut)) = NaN;
+    half_hz = 0;
+    half_us = 0;
+    if ~isempty(half)
+        [half_hz, kh] = max(em.half_hz(half));
+        kh = half(kh);
+        [half_us, ku] = max(em.half_us(half));
+        ku = half(ku);
+    end
+
+    [oob, ko] = max(oob_db(a));
+    n_oob = sum(oob_db(a) > max_oob_db);
+
+    fprintf('%-20s %5d %9.1f %6.1f | %5d %9.2f | %5d %9.1f %9.1f | %5d %9.1f\n', ...
+            builds{b}, n_hop, hop_rate, writes_per_hop, ...
+            n_jump, jump, length(half), half_hz, half_us, n_oob, oob);
+
+    % where the worst cases happened
+    fprintf('%-20s worst jump at %.0fus (%04X)', '', t(a(kj)), w(a(kj)));
+    if ~isempty(half)
+        fprintf(', worst half word at %.0fus (%04X)', t(kh), w(kh));
+        if ~isnan(half_us)
+            fprintf(', longest at %.0fus (%04X)', t(ku), w(ku));
+        end
+    end
+    fprintf(', worst oob at %.0fus (%04X)\n', t(a(ko)), w(a(ko)));
+end
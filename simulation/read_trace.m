@@ -0,0 +1,39 @@
+function [t, w, gap] = read_trace(file)
+    % Reads a log printed by AD9833::DumpTrace. Returns the write times
+    % in us, relative to the first write, and the 16-bit words. gap(k)
+    % is true if the log was dumped, or writes were dropped, right
+    % before write k, so the time since the previous write is not real.
+    fid = fopen(file);
+    if fid < 0
+        error('cannot open %s', file);
+    end
+    t = [];
+    w = [];
+    gap = false(0, 1);
+    after_dump = false;
+    line = fgetl(fid);
+    while ischar(line)
+        line = strtrim(line);
+        if ~isempty(line) && line(1) == '%'
+            if ~strcmp(strtrim(line(2:end)), 'dump')
+                warning('%s: %s', file, strtrim(line(2:end)));
+            end
+            after_dump = true;
+        elseif ~isempty(line)
+            fields = strsplit(line);
+            t(end+1, 1) = str2double(fields{1});
+            w(end+1, 1) = hex2dec(fields{2});
+            gap(end+1, 1) = after_dump;
+            after_dump = false;
+        end
+        line = fgetl(fid);
+    end
+    fclose(fid);
+    if isempty(t)
+        error('%s: no writes', file);
+    end
+
+    % micros() wraps around every 2^32 us
+    t = t - t(1);
+    t = t + cumsum([0; diff(t) < 0]) * 2^32;
+end